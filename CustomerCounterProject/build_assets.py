@@ -0,0 +1,137 @@
+"""
+@file build_assets.py
+
+@brief PlatformIO pre-script that builds the LittleFS image contents from data/.
+
+Web files (html, css, js) are minified and gzipped. Everything except the
+html pages is fingerprinted with a content hash and put under /assets/, so
+the ESP32 can serve it with an immutable Cache-Control header. The html
+pages keep their names, because they are the entry points the routes in
+main.cpp point at. Runtime files (csv, txt) are copied as they are.
+
+Nothing is fetched from the internet, neither here nor by the pages, so
+building works offline and the dashboard works on store networks without
+internet.
+
+The result is written to .pio/data, which is used as the data dir for
+`pio run -t buildfs` / `pio run -t uploadfs`.
+Can also be run by hand: `python build_assets.py`.
+"""
+
+import gzip
+import hashlib
+import os
+import re
+import shutil
+import sys
+
+# Files with these extensions are minified and gzipped.
+TEXT_EXTENSIONS = (".html", ".css", ".js", ".svg")
+# Files with these extensions are fingerprinted and placed in /assets/.
+ASSET_EXTENSIONS = (".css", ".js", ".png", ".ico", ".svg")
+
+
+def minify_html(text):
+    """Removes html comments, indentation and blank lines. Newlines are kept so inline // comments stay safe."""
+    text = re.sub(r"<!--.*?-->", "", text, flags=re.S)
+    lines = (line.strip() for line in text.splitlines())
+    return "\n".join(line for line in lines if line)
+
+
+def minify_css(text):
+    """Removes comments and the whitespace around css punctuation."""
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"\s+", " ", text)
+    text = re.sub(r"\s*([{};:,>])\s*", r"\1", text)
+    return text.replace(";}", "}").strip()
+
+
+def minify(name, data):
+    """Minifies a file based on its extension. Already minified files (*.min.js) are left alone."""
+    if name.endswith(".html"):
+        return minify_html(data.decode("utf-8")).encode("utf-8")
+    if name.endswith(".css"):
+        return minify_css(data.decode("utf-8")).encode("utf-8")
+    return data
+
+
+def fingerprint(name, data):
+    """Returns "assets/<stem>.<hash>.<ext>" for the given file."""
+    stem, ext = os.path.splitext(name)
+    digest = hashlib.sha256(data).hexdigest()[:8]
+    return "assets/%s.%s%s" % (stem, digest, ext)
+
+
+def write_file(path, data, compress):
+    """Writes data to path, gzipped if compress is set. mtime=0 keeps the output reproducible."""
+    os.makedirs(os.path.dirname(path), exist_ok=True)
+    if compress:
+        path += ".gz"
+        data = gzip.compress(data, compresslevel=9, mtime=0)
+    with open(path, "wb") as f:
+        f.write(data)
+    return len(data)
+
+
+def build(project_dir, out_dir):
+    """Builds the LittleFS contents of project_dir/data into out_dir."""
+    data_dir = os.path.join(project_dir, "data")
+
+    sources = {}
+    for name in sorted(os.listdir(data_dir)):
+        if os.path.isfile(os.path.join(data_dir, name)):
+            sources[name] = os.path.join(data_dir, name)
+
+    if os.path.isdir(out_dir):
+        shutil.rmtree(out_dir)
+    os.makedirs(out_dir)
+
+    # Fingerprint the assets first, so the html can be rewritten to point at them.
+    assets = {}
+    pages = {}
+    plain = {}
+    for name, path in sources.items():
+        with open(path, "rb") as f:
+            data = f.read()
+        if name.endswith(".html"):
+            pages[name] = data
+        elif name.endswith(ASSET_EXTENSIONS):
+            data = minify(name, data)
+            assets[name] = (fingerprint(name, data), data)
+        else:
+            plain[name] = data
+
+    raw_total = 0
+    out_total = 0
+    for name, (target, data) in assets.items():
+        raw_total += os.path.getsize(sources[name])
+        out_total += write_file(os.path.join(out_dir, target), data, name.endswith(TEXT_EXTENSIONS))
+        print("build_assets: %s -> /%s" % (name, target))
+
+    for name, data in pages.items():
+        raw_total += len(data)
+        text = data.decode("utf-8")
+        for asset, (target, _) in assets.items():
+            text = re.sub(r'(src|href)="/?%s"' % re.escape(asset), r'\1="/%s"' % target, text)
+        out_total += write_file(os.path.join(out_dir, name), minify(name, text.encode("utf-8")), True)
+        print("build_assets: %s -> /%s.gz" % (name, name))
+
+    for name, data in plain.items():
+        write_file(os.path.join(out_dir, name), data, False)
+
+    print("build_assets: web files %d bytes -> %d bytes" % (raw_total, out_total))
+
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO/SCons
+except NameError:
+    env = None
+
+if env is not None:
+    project_dir = env.subst("$PROJECT_DIR")
+    out_dir = os.path.join(env.subst("$PROJECT_WORKSPACE_DIR"), "data")
+    build(project_dir, out_dir)
+    env.Replace(PROJECT_DATA_DIR=out_dir)
+elif __name__ == "__main__":
+    here = os.path.dirname(os.path.abspath(sys.argv[0]))
+    build(here, os.path.join(here, ".pio", "data"))
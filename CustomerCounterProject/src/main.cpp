@@ -46,6 +46,10 @@
 #include <AsyncTCP.h>
 #include <WiFiUdp.h>
 #include <ArduinoJson.h>
+#include <esp_partition.h>
+#include <StreamString.h>
+#include <vector>
+#include <algorithm>
 
 // Create AsyncWebServer object on port 80
 AsyncWebServer server(80);
@@ -77,6 +81,25 @@ const char* ssidPath = "/ssid.txt";
 const char* passPath = "/pass.txt";
 const char* csvPath = "/customer-list.csv";
 
+/**
+ * @brief File paths for the cached connection of the last WiFi. Used by initWiFi() and superviseWiFi() to skip the scan and DHCP.
+ */
+const char* channelPath = "/channel.txt";
+const char* bssidPath = "/bssid.txt";
+const char* ipPath = "/ip.txt";
+const char* gatewayPath = "/gateway.txt";
+const char* subnetPath = "/subnet.txt";
+const char* dnsPath = "/dns.txt";
+
+/**
+ * @brief Cache headers for the web files made by build_assets.py
+ * @details Files in /assets/ have a content hash in their name, so they never change and can be cached forever.
+ *          The html pages keep their names and must be revalidated so they pick up new asset names.
+ */
+const char* assetsPath = "/assets/";
+const char* assetCacheControl = "public, max-age=31536000, immutable";
+const char* pageCacheControl = "no-cache";
+
 /**
  * @brief Variables to save values from HTML form
  */
@@ -97,6 +120,11 @@ bool isTouched = false;
  */
 bool isConnectedWiFi = false;
 
+/** 
+ * @brief Boolean to check if the ESP is in AP mode but still tries to connect to the saved WiFi
+ */
+bool isRetryingWiFi = false;
+
 /**
  * @brief Is the LocalIP of the ESP32
  */
@@ -107,6 +135,98 @@ IPAddress localIP;
  */
 IPAddress localGateway;
 IPAddress subnet(255, 255, 0, 0);
+IPAddress localDNS;
+
+/**
+ * @brief Cached channel and BSSID of the last WiFi
+ */
+int wifiChannel = 0;
+uint8_t wifiBSSID[6];
+bool hasWiFiCache = false;
+
+/**
+ * @brief Variables for the WiFi supervisor
+ */
+const unsigned long fastConnectTimeout = 1500;  ///< Time to wait for a connection that uses the cache (milliseconds)
+const unsigned long reconnectMaxBackoff = 8000;  ///< Max wait between reconnect attempts (milliseconds)
+bool isWiFiLost = false;
+unsigned long wifiLostMillis = 0;
+unsigned long nextReconnectMillis = 0;
+unsigned long reconnectBackoff = 0;
+int reconnectAttempts = 0;
+int reconnectCount = 0;
+unsigned long lastReconnectDuration = 0;
+
+/**
+ * @brief Page size for the /events route
+ */
+const int eventsDefaultLimit = 50;
+const int eventsMaxLimit = 200;
+
+/**
+ * @brief Generation of the CSV file, part of the /events cursor
+ * @details Random at boot and changed every time the CSV file is rewritten (remove, clear), so a cursor
+ *          from before a rewrite or a reboot is rejected instead of pointing into the wrong rows.
+ *          Appends keep the generation, since they don't move the rows a cursor points at.
+ */
+uint32_t csvGeneration = 0;
+
+/**
+ * @brief Max number of rows in the /get-data-bench test data, so it fits in RAM
+ */
+const int dataBenchMaxRows = 3000;
+
+/**
+ * @brief Max number of days /get-data?format=bin covers, so a corrupt date can't make countDays() allocate too much
+ */
+const long maxDaySpan = 3660;
+
+/**
+ * @brief The kinds of storage operations that are counted for write amplification
+ */
+enum StorageOp { OP_APPEND, OP_REMOVE_LATEST, OP_REMOVE_DATE, OP_CLEAR, OP_CONFIG, OP_COUNT };
+
+/**
+ * @brief Write counters for one kind of storage operation
+ * @details logicalBytes is what the operation actually changes (e.g. one CSV line), fileBytes is what is written
+ *          through LittleFS, and flashBytes/erasedBlocks is what LittleFS programs and erases on the flash.
+ */
+struct StorageStats {
+  const char* name;
+  unsigned long operations;
+  unsigned long logicalBytes;
+  unsigned long fileBytes;
+  unsigned long flashBytes;
+  unsigned long erasedBlocks;
+};
+StorageStats storageStats[OP_COUNT] = {{"append"}, {"remove-latest"}, {"remove-date"}, {"clear"}, {"config"}};
+StorageStats benchStats[OP_COUNT] = {{"append"}, {"remove-latest"}, {"remove-date"}, {"clear"}, {"config"}};  ///< Counters for operations on benchPath
+
+/**
+ * @brief Held during every counted storage operation, so operations from loop() and the web server
+ *        never overlap and the flash counters only see one operation at a time.
+ */
+SemaphoreHandle_t storageMutex = nullptr;
+
+/**
+ * @brief Bytes programmed and blocks erased on the LittleFS partition, counted by the esp_partition wrappers
+ */
+unsigned long flashBytesWritten = 0;
+unsigned long flashBlocksErased = 0;
+
+/**
+ * @brief Variables for the storage benchmark
+ */
+const char* benchPath = "/bench.csv";
+const unsigned long flashEraseCycles = 100000;  ///< Rated erase cycles per flash block
+const int benchMaxRows = 2000;  ///< Max rows in the benchmark file, so removeLinesWithDate() can hold it in RAM
+bool isBenchmarkRequested = false;
+int benchHistoryDays = 5;
+int benchTouchesPerDay = 300;
+int benchStep = -1;  ///< Next step of the running benchmark, -1 when it is not running
+unsigned long benchStartMillis = 0;
+String benchDate;
+String benchReport;
 
 /**
  * @brief Timer variables
@@ -118,12 +238,87 @@ const long interval = 10000;  ///< interval to wait for Wi-Fi connection (millis
  * @brief Initialize LittleFS
  */
 void initLittleFS() {
+  storageMutex = xSemaphoreCreateRecursiveMutex();
   if (!LittleFS.begin(true)) {
     Serial.println("An error has occurred while mounting LittleFS");
   }
   Serial.println("LittleFS mounted successfully");
 }
 
+/**
+ * @brief Checks if a partition is the one LittleFS is mounted on (it uses the spiffs subtype).
+ */
+bool isLittleFSPartition(const esp_partition_t* partition) {
+  return partition->type == ESP_PARTITION_TYPE_DATA && partition->subtype == ESP_PARTITION_SUBTYPE_DATA_SPIFFS;
+}
+
+/**
+ * @brief Counts the bytes LittleFS programs on the flash.
+ * @details Linked in with -Wl,--wrap=esp_partition_write (see platformio.ini).
+ */
+extern "C" esp_err_t __real_esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size);
+extern "C" esp_err_t __wrap_esp_partition_write(const esp_partition_t* partition, size_t dst_offset, const void* src, size_t size) {
+  if (isLittleFSPartition(partition)) flashBytesWritten += size;
+  return __real_esp_partition_write(partition, dst_offset, src, size);
+}
+
+/**
+ * @brief Counts the blocks LittleFS erases on the flash.
+ * @details Linked in with -Wl,--wrap=esp_partition_erase_range (see platformio.ini).
+ */
+extern "C" esp_err_t __real_esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size);
+extern "C" esp_err_t __wrap_esp_partition_erase_range(const esp_partition_t* partition, size_t offset, size_t size) {
+  if (isLittleFSPartition(partition)) flashBlocksErased += size / SPI_FLASH_SEC_SIZE;
+  return __real_esp_partition_erase_range(partition, offset, size);
+}
+
+/**
+ * @brief Counts the writes of one storage operation.
+ * @details Create it at the start of the operation and call record() when it is done. It holds storageMutex
+ *          while it exists, so the flash counters only see this operation. Operations on benchPath are
+ *          counted in benchStats, everything else in storageStats.
+ */
+class StorageOpCounter {
+public:
+  StorageOpCounter(const char* path) : stats(strcmp(path, benchPath) == 0 ? benchStats : storageStats) {
+    xSemaphoreTakeRecursive(storageMutex, portMAX_DELAY);
+    flashBytesBefore = flashBytesWritten;
+    erasedBlocksBefore = flashBlocksErased;
+  }
+
+  ~StorageOpCounter() {
+    xSemaphoreGiveRecursive(storageMutex);
+  }
+
+  /**
+   * @brief Adds the finished operation to the write counters.
+   * @param op The kind of operation
+   * @param logicalBytes Bytes the operation actually changed
+   * @param fileBytes Bytes written through LittleFS
+   */
+  void record(StorageOp op, size_t logicalBytes, size_t fileBytes) {
+    StorageStats &entry = stats[op];
+    entry.operations++;
+    entry.logicalBytes += logicalBytes;
+    entry.fileBytes += fileBytes;
+    entry.flashBytes += flashBytesWritten - flashBytesBefore;
+    entry.erasedBlocks += flashBlocksErased - erasedBlocksBefore;
+  }
+
+private:
+  StorageStats* stats;
+  unsigned long flashBytesBefore;
+  unsigned long erasedBlocksBefore;
+};
+
+/**
+ * @brief Changes csvGeneration if path is the CSV file, so old /events cursors become stale.
+ * @param path Path of the file that was rewritten
+ */
+void markRewritten(const char* path) {
+  if (strcmp(path, csvPath) == 0) csvGeneration++;
+}
+
 /**
  * @brief Read File from LittleFS
  * @param fs File system to read from
@@ -178,16 +373,21 @@ const char* readCsvFile(fs::FS &fs, const char * path){
 void writeToConfigFiles(fs::FS &fs, const char * path, const char * message){
   Serial.printf("Writing file: %s\r\n", path);
 
+  StorageOpCounter counter(path);
+
   File file = fs.open(path, FILE_WRITE); // Opens file path in write.
   if(!file){ // Checks if file opened successfully.
     Serial.println("- failed to open file for writing");
     return;
   }
-  if(file.print(message)){ // Checks if printing the "message" to file was successful or not.
+  size_t fileBytes = file.print(message);
+  if(fileBytes){ // Checks if printing the "message" to file was successful or not.
     Serial.println("- file written");
   } else {
     Serial.println("- write failed");
   }
+  file.close();
+  counter.record(OP_CONFIG, strlen(message), fileBytes);
 }
 
 /**
@@ -198,6 +398,8 @@ void writeToConfigFiles(fs::FS &fs, const char * path, const char * message){
  * @return true if success, false otherwise
  */
 bool appendToCSV(const char * path, String currentDate, String currentTime) {
+  StorageOpCounter counter(path);
+
   // Open the CSV file in append mode
   File file = LittleFS.open(path, FILE_APPEND);
   if(!file){  // Check if the file opened successfully
@@ -206,15 +408,18 @@ bool appendToCSV(const char * path, String currentDate, String currentTime) {
   }
 
   // Write the header if the file is empty
+  size_t fileBytes = 0;
   if (file.size() == 0) {  // If the file is empty, add a header
-    file.println("customer,date,time");
+    fileBytes += file.println("customer,date,time");
   }
 
   // Format and write the data
   String dataLine = "1," + currentDate + "," + currentTime;  // Prepare data line
-  file.println(dataLine);  // Write the data to the file
+  size_t lineBytes = file.println(dataLine);  // Write the data to the file
+  fileBytes += lineBytes;
 
   file.close();  // Close the file
+  counter.record(OP_APPEND, lineBytes, fileBytes);
   Serial.println("Line "+ dataLine +" appended to CSV file successfully!");  // Log success
   return true;  // Return success
 }
@@ -226,6 +431,8 @@ bool appendToCSV(const char * path, String currentDate, String currentTime) {
  * @return true if success, false otherwise
  */
 bool removeLatestEntryOnDate(const char * path, String targetDate) {
+  StorageOpCounter counter(path);
+
   // Open the CSV file in read mode
   File file = LittleFS.open(path, FILE_READ);
   if(!file){
@@ -244,6 +451,8 @@ bool removeLatestEntryOnDate(const char * path, String targetDate) {
   // Read the CSV file line by line
   String line;
   bool foundLatest = false;
+  size_t removedBytes = 0;
+  size_t fileBytes = 0;
   while (file.available()) {
     line = file.readStringUntil('\n');
 
@@ -256,11 +465,12 @@ bool removeLatestEntryOnDate(const char * path, String targetDate) {
     // skip writing this line to the temporary file
     if (currentDate == targetDate && !foundLatest) {
       foundLatest = true;
+      removedBytes = line.length() + 1;  // The line and its '\n'
       continue;
     }
 
     // Write the line to the temporary file
-    tempFile.println(line);
+    fileBytes += tempFile.println(line);
   }
 
   // Close both files
@@ -272,6 +482,8 @@ bool removeLatestEntryOnDate(const char * path, String targetDate) {
 
   // Rename the temporary file to the original CSV file
   LittleFS.rename("/temp.csv", path);
+  markRewritten(path);
+  counter.record(OP_REMOVE_LATEST, removedBytes, fileBytes);
 
   Serial.println("Latest entry on " + targetDate + " removed successfully!");
   return true;
@@ -284,6 +496,8 @@ bool removeLatestEntryOnDate(const char * path, String targetDate) {
  * @return true if success, false otherwise
  */
 bool removeLinesWithDate(const char* path, const String& inputDate) {
+  StorageOpCounter counter(path);
+
   // Open the CSV file for reading
   File file = LittleFS.open(path, "r");
   if (!file) {
@@ -291,8 +505,15 @@ bool removeLinesWithDate(const char* path, const String& inputDate) {
     return false;
   }
 
-  // Temporary storage for modified content
+  // Temporary storage for modified content. The result is never bigger than the file, so reserving
+  // that up front means no line can be dropped by a failed reallocation later.
   String modifiedContent = "";
+  if (!modifiedContent.reserve(file.size())) {
+    Serial.println("Not enough memory to rewrite the file");
+    file.close();
+    return false;
+  }
+  size_t removedBytes = 0;
 
   // Read file line-by-line
   while (file.available()) {
@@ -325,6 +546,8 @@ bool removeLinesWithDate(const char* path, const String& inputDate) {
     // Only add lines to modified content if the date doesn't match inputDate
     if (date != inputDate) {
       modifiedContent += line + "\n";
+    } else {
+      removedBytes += line.length() + 1;
     }
   }
 
@@ -338,8 +561,10 @@ bool removeLinesWithDate(const char* path, const String& inputDate) {
   }
 
   // Write the modified content back to the file
-  file.print(modifiedContent);
+  size_t fileBytes = file.print(modifiedContent);
   file.close();
+  markRewritten(path);
+  counter.record(OP_REMOVE_DATE, removedBytes, fileBytes);
 
   Serial.println("Lines with date " + inputDate + " have been removed from the CSV.");
   return true;
@@ -351,6 +576,8 @@ bool removeLinesWithDate(const char* path, const String& inputDate) {
  * @return true if success, false otherwise
  */
 bool clearFile(const char* path) {
+  StorageOpCounter counter(path);
+
   // Open the file in write mode, which empties it immediately
   File file = LittleFS.open(path, "w");
   if (!file) {
@@ -359,17 +586,129 @@ bool clearFile(const char* path) {
   }
   
   file.close();  // Close the file after opening in write mode (now empty)
+  markRewritten(path);
+  counter.record(OP_CLEAR, 0, 0);
   Serial.println("File has been cleared successfully.");
   return true;
 }
 
+/**
+ * @brief Sends a html page from LittleFS.
+ * @details The page is stored as "<path>.gz" by build_assets.py. AsyncFileResponse picks the .gz file
+ *          and sets "Content-Encoding: gzip" by itself.
+ *          Sends a 404 if the page is missing, like request->send(LittleFS, ...) does.
+ * @param request The incoming HTTP request
+ * @param path Path to the html page
+ */
+void sendPage(AsyncWebServerRequest *request, const char* path) {
+  AsyncWebServerResponse *response = request->beginResponse(LittleFS, path, "text/html");
+  if (response == nullptr) {  // Neither the page nor its .gz is on LittleFS (e.g. the image was built without build_assets.py)
+    request->send(404, "text/plain", "Page not found.");
+    return;
+  }
+  response->addHeader("Cache-Control", pageCacheControl);
+  request->send(response);
+}
+
+/**
+ * @brief Loads the cached channel, BSSID and IP config of the last WiFi.
+ * @return true if there is a complete cache, false otherwise
+ */
+bool loadWiFiCache() {
+  ip = readConfigFiles(LittleFS, ipPath);
+  gateway = readConfigFiles(LittleFS, gatewayPath);
+  wifiChannel = readConfigFiles(LittleFS, channelPath).toInt();
+  String bssid = readConfigFiles(LittleFS, bssidPath);
+
+  if (wifiChannel <= 0) return false;
+  if (sscanf(bssid.c_str(), "%hhx:%hhx:%hhx:%hhx:%hhx:%hhx",
+             &wifiBSSID[0], &wifiBSSID[1], &wifiBSSID[2], &wifiBSSID[3], &wifiBSSID[4], &wifiBSSID[5]) != 6) return false;
+  if (!localIP.fromString(ip) || !localGateway.fromString(gateway)) return false;
+  if (!subnet.fromString(readConfigFiles(LittleFS, subnetPath))) return false;
+  if (!localDNS.fromString(readConfigFiles(LittleFS, dnsPath))) localDNS = localGateway;
+  return true;
+}
+
+/**
+ * @brief Saves the channel, BSSID and IP config of the current WiFi connection.
+ * @details Only writes when something has changed, so a normal boot does not write to flash.
+ */
+void saveWiFiCache() {
+  String bssid = WiFi.BSSIDstr();
+  String newIp = WiFi.localIP().toString();
+  String newGateway = WiFi.gatewayIP().toString();
+  if (hasWiFiCache && WiFi.channel() == wifiChannel && memcmp(WiFi.BSSID(), wifiBSSID, 6) == 0
+      && newIp == ip && newGateway == gateway && WiFi.subnetMask() == subnet && WiFi.dnsIP() == localDNS) {
+    return;
+  }
+
+  writeToConfigFiles(LittleFS, channelPath, String(WiFi.channel()).c_str());
+  writeToConfigFiles(LittleFS, bssidPath, bssid.c_str());
+  writeToConfigFiles(LittleFS, ipPath, newIp.c_str());
+  writeToConfigFiles(LittleFS, gatewayPath, newGateway.c_str());
+  writeToConfigFiles(LittleFS, subnetPath, WiFi.subnetMask().toString().c_str());
+  writeToConfigFiles(LittleFS, dnsPath, WiFi.dnsIP().toString().c_str());
+  hasWiFiCache = loadWiFiCache();
+}
+
+/**
+ * @brief Clears the cached channel, BSSID and IP config.
+ * @return true if success, false otherwise
+ */
+bool clearWiFiCache() {
+  hasWiFiCache = false;
+  bool isCleared = true;
+  const char* paths[] = {channelPath, bssidPath, ipPath, gatewayPath, subnetPath, dnsPath};
+  for (const char* path : paths) {
+    isCleared = clearFile(path) && isCleared;
+  }
+  return isCleared;
+}
+
+/**
+ * @brief Starts a WiFi connection attempt. Does not wait for it to finish.
+ * @param useCache true to connect straight to the cached channel and BSSID with the cached static IP.
+ *                 This skips the scan and DHCP. false does a full scan and uses DHCP.
+ * @return true if the attempt was started, false otherwise
+ */
+bool beginWiFi(bool useCache) {
+  bool isConfigured = useCache ? WiFi.config(localIP, localGateway, subnet, localDNS)
+                               : WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+  if (!isConfigured) {
+    Serial.println("STA Failed to configure");
+    return false;
+  }
+
+  if (useCache) {
+    WiFi.begin(ssid.c_str(), pass.c_str(), wifiChannel, wifiBSSID);
+  } else {
+    WiFi.begin(ssid.c_str(), pass.c_str());
+  }
+  return true;
+}
+
+/**
+ * @brief Waits for the WiFi to connect.
+ * @param timeout Max time to wait (milliseconds)
+ * @return true if connected, false if it timed out
+ */
+bool waitForWiFi(unsigned long timeout) {
+  previousMillis = millis();
+  while (WiFi.status() != WL_CONNECTED) {
+    if (millis() - previousMillis >= timeout) return false;
+    delay(10);
+  }
+  return true;
+}
+
 /**
  * @brief Initializes and connects to Wi-Fi using the provided SSID and password.
  * 
- * This function sets up the Wi-Fi in station mode, configures the IP address, 
- * and attempts to connect to the specified Wi-Fi network. If the connection fails 
- * within a set timeout interval, it returns `false` and retries. On successful connection, 
- * it returns `true` and stores the IP address.
+ * This function sets up the Wi-Fi in station mode and first tries to connect with the cached 
+ * channel, BSSID and IP config from the last connection, which skips the scan and DHCP. 
+ * If there is no cache or it fails, it does a full scan and uses DHCP. If the connection fails 
+ * within a set timeout interval, it returns `false`. On successful connection, 
+ * it returns `true` and caches the connection for next time.
  * 
  * @return bool `true` if Wi-Fi is successfully connected, `false` otherwise.
  */
@@ -379,41 +718,88 @@ bool initWiFi() {
     return false;
   }
 
+  unsigned long startMillis = millis();
   WiFi.mode(WIFI_STA);  // Set WiFi mode to station (STA)
-
-  if (!WiFi.config(localIP, localGateway, subnet)){  // Configure static IP
-    Serial.println("STA Failed to configure");
-    return false;
+  WiFi.setAutoReconnect(false);  // superviseWiFi() handles reconnects
+
+  bool isConnected = false;
+  hasWiFiCache = loadWiFiCache();
+  if (hasWiFiCache) {  // Try the fast connect first
+    Serial.println("Connecting to WiFi with cached channel " + String(wifiChannel) + "...");
+    isConnected = beginWiFi(true) && waitForWiFi(fastConnectTimeout);
+    if (!isConnected) {
+      Serial.println("Fast connect failed. Doing a full scan.");
+      WiFi.disconnect();
+    }
   }
-  WiFi.begin(ssid.c_str(), pass.c_str());  // Start WiFi connection
-  Serial.println("Connecting to WiFi...");
 
-  unsigned long currentMillis = millis();  // Get current time
-  previousMillis = currentMillis;
+  if (!isConnected) {
+    Serial.println("Connecting to WiFi...");
+    isConnected = beginWiFi(false) && waitForWiFi(interval);
+  }
 
-  while(WiFi.status() != WL_CONNECTED) {  // Wait for connection
-    currentMillis = millis();
-    if (currentMillis - previousMillis >= interval) {  // Timeout check
-      Serial.println("Failed to connect.");
-      return false;
-    }
+  if (!isConnected) {
+    Serial.println("Failed to connect.");
+    return false;
   }
 
+  Serial.printf("Connected in %lu ms\r\n", millis() - startMillis);
   Serial.println(WiFi.localIP());  // Print local IP address after connection
+  saveWiFiCache();
   isConnectedWiFi = true;  // Set WiFi connected flag
   return isConnectedWiFi;  // Return connection status
 }
 
+/**
+ * @brief Keeps the WiFi connected. Called from loop().
+ * 
+ * When the connection is lost, it reconnects with a backoff between the attempts. 
+ * Every other attempt uses the cached channel and BSSID, since a rebooted router normally 
+ * comes back on the same ones. The others do a full scan in case the channel changed. 
+ * The time it took to reconnect is printed and can be read from /wifi-status.
+ */
+void superviseWiFi() {
+  unsigned long currentMillis = millis();
+
+  if (WiFi.status() == WL_CONNECTED) {
+    if (isWiFiLost) {
+      isWiFiLost = false;
+      lastReconnectDuration = currentMillis - wifiLostMillis;
+      reconnectCount++;
+      Serial.printf("WiFi reconnected in %lu ms after %d attempt(s)\r\n", lastReconnectDuration, reconnectAttempts);
+      saveWiFiCache();
+    }
+    return;
+  }
+
+  if (!isWiFiLost) {
+    Serial.println("WiFi connection lost.");
+    isWiFiLost = true;
+    wifiLostMillis = currentMillis;
+    nextReconnectMillis = currentMillis;
+    reconnectBackoff = 0;
+    reconnectAttempts = 0;
+  }
+
+  if ((long)(currentMillis - nextReconnectMillis) < 0) return;  // Wait for the backoff
+
+  bool useCache = hasWiFiCache && reconnectAttempts % 2 == 0;
+  WiFi.disconnect();
+  beginWiFi(useCache);
+  reconnectAttempts++;
+
+  // Give the attempt time to finish, then wait a bit longer after every failed attempt
+  nextReconnectMillis = currentMillis + (useCache ? fastConnectTimeout : interval) + reconnectBackoff;
+  reconnectBackoff = reconnectBackoff == 0 ? 500 : min(reconnectBackoff * 2, reconnectMaxBackoff);
+}
+
 /**
  * @brief Counts occurrences of each date in a CSV string.
  * @param csv The CSV data as a C-string.
  * @return JSON string with dates and their counts.
  */
 String countDates(const char* csv) {
-  const int MAX_DATES = 50; // Maximum expected unique dates
-  String dates[MAX_DATES];  // Array to store dates
-  int counts[MAX_DATES] = {0};  // Array to count occurrences
-  int uniqueDateCount = 0;  // Counter for unique dates
+  JsonDocument jsonDoc;  // Dates and their counts, in the order they are found
 
   String csvString = String(csv);
   int startIdx = 0;
@@ -431,34 +817,270 @@ String countDates(const char* csv) {
     int secondCommaIdx = line.indexOf(",", commaIdx + 1);
     String date = line.substring(commaIdx + 1, secondCommaIdx);
 
+    // Increment the count, a new date starts at 0
+    jsonDoc[date] = jsonDoc[date].as<int>() + 1;
+  }
 
-    // Check if the date is already in the list
-    bool found = false;
-    for (int i = 0; i < uniqueDateCount; i++) {
-      if (dates[i] == date) {
-        counts[i]++;  // Increment count if date is found
-        found = true;
-        break;
-      }
+  String jsonOutput;
+  serializeJson(jsonDoc, jsonOutput);
+  return jsonOutput; // Store each date with its count
+}
+
+/**
+ * @brief Gets the date field of a CSV line ("customer,date,time").
+ * @param line The CSV line
+ * @return The date string, or an empty string if the line is malformed.
+ */
+String getDateFromLine(const String& line) {
+  int commaIdx = line.indexOf(',');
+  int secondCommaIdx = line.indexOf(',', commaIdx + 1);
+  if (commaIdx == -1 || secondCommaIdx == -1) return String();
+  return line.substring(commaIdx + 1, secondCommaIdx);
+}
+
+/**
+ * @brief Converts a "yyyy/mm/dd" date to days since 1970/01/01.
+ * @param date The date string
+ * @return The day number, or -1 if the date is malformed or not between 1970 and 2099.
+ */
+long dateToDay(const String& date) {
+  int year, month, day;
+  if (sscanf(date.c_str(), "%d/%d/%d", &year, &month, &day) != 3) return -1;
+  if (year < 1970 || year > 2099 || month < 1 || month > 12) return -1;
+
+  const int daysInMonth[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  bool isLeapYear = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+  if (day < 1 || day > daysInMonth[month - 1] + (month == 2 && isLeapYear ? 1 : 0)) return -1;
+
+  // Days from the civil calendar, with the year starting in March so the leap day is last
+  if (month <= 2) year--;
+  long era = year / 400;
+  long yearOfEra = year - era * 400;
+  long dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  long dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+  return era * 146097 + dayOfEra - 719468;
+}
+
+/**
+ * @brief Counts the rows per day in CSV data.
+ * @param csv The CSV data, e.g. the opened CSV file
+ * @param counts Set to the count of each day from startDay. Days without rows are 0.
+ * @param startDay Set to the first day (days since 1970/01/01)
+ * @details The counts cover at most maxDaySpan days. The window with the most rows is kept (the newest one if there is a tie),
+ *          so a few corrupt dates far away from the rest are dropped instead of the real data, and can't make the vector huge.
+ */
+void countDays(Stream &csv, std::vector<uint32_t> &counts, long &startDay) {
+  counts.clear();
+  startDay = 0;
+
+  // Count per day first. Only days that have rows are stored, so a far away date costs one entry and not a gap.
+  std::vector<std::pair<long, uint32_t>> dayCounts;  // Sorted by day
+  while (csv.available()) {
+    String line = csv.readStringUntil('\n');
+    if (line.length() == 0 || line.startsWith("customer")) continue; // Skip empty or header lines
+
+    long day = dateToDay(getDateFromLine(line));
+    if (day < 0) continue;  // Skip malformed lines
+
+    if (dayCounts.empty() || day > dayCounts.back().first) {  // The file is appended in time order, so this is the normal case
+      dayCounts.push_back({day, 1});
+    } else if (day == dayCounts.back().first) {
+      dayCounts.back().second++;
+    } else {  // Rows out of order
+      auto it = std::lower_bound(dayCounts.begin(), dayCounts.end(), std::make_pair(day, (uint32_t)0));
+      if (it != dayCounts.end() && it->first == day) it->second++;
+      else dayCounts.insert(it, {day, 1});
+    }
+  }
+  if (dayCounts.empty()) return;
+
+  // Find the maxDaySpan days window with the most rows
+  size_t first = 0;
+  size_t bestFirst = 0;
+  size_t bestLast = 0;
+  unsigned long windowRows = 0;
+  unsigned long bestRows = 0;
+  for (size_t last = 0; last < dayCounts.size(); last++) {
+    windowRows += dayCounts[last].second;
+    while (dayCounts[last].first - dayCounts[first].first >= maxDaySpan) windowRows -= dayCounts[first++].second;
+    if (windowRows >= bestRows) {
+      bestRows = windowRows;
+      bestFirst = first;
+      bestLast = last;
     }
+  }
+  if (bestFirst > 0 || bestLast < dayCounts.size() - 1) {
+    Serial.println("Skipped rows with dates more than " + String(maxDaySpan) + " days from the rest.");
+  }
+
+  startDay = dayCounts[bestFirst].first;
+  counts.assign(dayCounts[bestLast].first - startDay + 1, 0);
+  for (size_t i = bestFirst; i <= bestLast; i++) counts[dayCounts[i].first - startDay] = dayCounts[i].second;
+}
 
-    // Add new date if not found
-    if (!found) {
-      dates[uniqueDateCount] = date;
-      counts[uniqueDateCount] = 1;
-      uniqueDateCount++;
+/**
+ * @brief Read-only Stream over a C-string.
+ * @details Lets data in RAM be passed to functions that read a Stream (like countDays()) without copying it.
+ *          Reading only moves an index, unlike StreamString which removes the first char on every read.
+ */
+class CharStream : public Stream {
+public:
+  CharStream(const char* data, size_t length) : data(data), length(length), position(0) {
+    setTimeout(0);  // All the data is already here, don't wait for more at the end
+  }
+
+  int available() { return length - position; }
+  int read() { return position < length ? (uint8_t)data[position++] : -1; }
+  int peek() { return position < length ? (uint8_t)data[position] : -1; }
+  size_t write(uint8_t) { return 0; }
+  void flush() {}
+
+private:
+  const char* data;
+  size_t length;
+  size_t position;
+};
+
+/**
+ * @brief Writes day counts in the binary /get-data format.
+ * @details Little-endian uint32 values: start day (days since 1970/01/01), bucket size in days, number of buckets,
+ *          and then one count per bucket. The header is 12 bytes, so the browser can read the counts directly as a Uint32Array.
+ * @param out Where to write to
+ * @param counts The count of each day
+ * @param startDay The first day
+ * @return Number of bytes written
+ */
+size_t writeDayCounts(Print &out, const std::vector<uint32_t> &counts, long startDay) {
+  auto writeUint32 = [&out](uint32_t value) {
+    uint8_t bytes[4] = {(uint8_t)value, (uint8_t)(value >> 8), (uint8_t)(value >> 16), (uint8_t)(value >> 24)};
+    return out.write(bytes, sizeof(bytes));
+  };
+
+  size_t written = writeUint32(startDay);
+  written += writeUint32(1);  // Bucket size in days
+  written += writeUint32(counts.size());
+  for (uint32_t count : counts) written += writeUint32(count);
+  return written;
+}
+
+/**
+ * @brief Moves the file to the first line where the date is on or after targetDate.
+ * @details The CSV is appended in time order, so the dates are sorted and yyyy/mm/dd compares as text.
+ *          This does a binary search over the byte offsets, so only a few lines are read instead of the whole file.
+ * @param file The opened CSV file
+ * @param targetDate Date in "yyyy/mm/dd" format
+ * @return Byte offset of the found line, or the file size if there is none. The file is left at that offset.
+ */
+size_t seekToDate(File &file, const String& targetDate) {
+  size_t low = 0;  // Line start, every line before it is older than targetDate
+  size_t high = file.size();  // Line start with a date on or after targetDate (or end of file)
+
+  // Skip the header
+  file.seek(0);
+  if (file.readStringUntil('\n').startsWith("customer")) low = file.position();
+
+  while (high - low > 1) {
+    size_t mid = low + (high - low) / 2;
+
+    // Find the first line that starts on or after mid
+    file.seek(mid - 1);
+    if (file.read() != '\n') file.readStringUntil('\n');
+    size_t lineStart = file.position();
+    if (lineStart >= high) break;  // No line starts between mid and high, scan the rest
+
+    String line = file.readStringUntil('\n');
+    if (getDateFromLine(line) < targetDate) {
+      low = file.position();
+    } else {
+      high = lineStart;
     }
   }
 
-  // Convert to JSON
-  JsonDocument jsonDoc;
-  for (int i = 0; i < uniqueDateCount; i++) {
-    jsonDoc[dates[i]] = counts[i];
+  // Scan what is left between low and high
+  file.seek(low);
+  while (file.position() < high) {
+    size_t lineStart = file.position();
+    if (getDateFromLine(file.readStringUntil('\n')) >= targetDate) {
+      high = lineStart;
+      break;
+    }
   }
 
-  String jsonOutput;
-  serializeJson(jsonDoc, jsonOutput);
-  return jsonOutput; // Store each date with its count
+  file.seek(high);
+  return high;
+}
+
+/**
+ * @brief Reads one page of events from the CSV file, starting at the current file position.
+ * @param file The opened CSV file, positioned at the start of a line
+ * @param events JSON array to add the events to
+ * @param limit Max number of events to read
+ * @param fromDate Skip events before this date (empty for no filter)
+ * @param toDate Stop at events after this date (empty for no filter)
+ * @return Byte offset to continue from, or 0 if there are no more events.
+ */
+size_t readEvents(File &file, JsonArray events, int limit, const String& fromDate, const String& toDate) {
+  int count = 0;
+  while (file.available()) {
+    if (count >= limit) return file.position();
+
+    String line = file.readStringUntil('\n');
+    line.trim();
+    if (line.length() == 0 || line.startsWith("customer")) continue;  // Skip empty or header lines
+
+    String date = getDateFromLine(line);
+    if (date.length() == 0) continue;  // Skip malformed lines
+    if (toDate.length() > 0 && date > toDate) return 0;  // Dates are sorted, nothing more to find
+    if (fromDate.length() > 0 && date < fromDate) continue;
+
+    JsonObject event = events.add<JsonObject>();
+    event["date"] = date;
+    event["time"] = line.substring(line.lastIndexOf(',') + 1);
+    count++;
+  }
+  return 0;
+}
+
+/**
+ * @brief Parses a HTTP Range header with a single byte range.
+ * @details Supports "bytes=a-b", "bytes=a-" and "bytes=-n". A header that can't be parsed or has more
+ *          than one range is ignored, like the RFC says, and the whole body is used.
+ * @param header The value of the Range header
+ * @param length Length of the whole body
+ * @param start Set to the first byte to send
+ * @param end Set to one past the last byte to send
+ * @return false if the range is unsatisfiable (416), true otherwise
+ */
+bool parseRange(const String& header, size_t length, size_t &start, size_t &end) {
+  start = 0;
+  end = length;
+  if (!header.startsWith("bytes=") || header.indexOf(',') != -1) return true;
+
+  String spec = header.substring(6);
+  spec.trim();
+  int dashIdx = spec.indexOf('-');
+  if (dashIdx == -1) return true;
+  String first = spec.substring(0, dashIdx);
+  String last = spec.substring(dashIdx + 1);
+
+  if (first.length() == 0) {  // Suffix range: the last n bytes
+    size_t suffix = strtoul(last.c_str(), nullptr, 10);
+    if (suffix == 0) return false;
+    start = suffix < length ? length - suffix : 0;
+    return true;
+  }
+
+  start = strtoul(first.c_str(), nullptr, 10);
+  if (start >= length) return false;
+  if (last.length() > 0) {
+    size_t lastByte = strtoul(last.c_str(), nullptr, 10);
+    if (lastByte < start) {  // Invalid, ignore the header
+      start = 0;
+      return true;
+    }
+    end = min(lastByte + 1, length);
+  }
+  return true;
 }
 
 /**
@@ -489,6 +1111,168 @@ String getDate(tm timeInfo){
   return date;
 }
 
+/**
+ * @brief Adds write counters to a JSON object, one entry per kind of operation and one for the total.
+ * @param stats Array of OP_COUNT counters
+ * @param json JSON object to add them to
+ * @return The total of all the counters
+ */
+StorageStats addStorageStatsToJson(const StorageStats* stats, JsonObject json) {
+  StorageStats total = {"total"};
+  for (int op = 0; op <= OP_COUNT; op++) {
+    const StorageStats &entry = op < OP_COUNT ? stats[op] : total;
+    JsonObject entryJson = json[entry.name].to<JsonObject>();
+    entryJson["operations"] = entry.operations;
+    entryJson["logicalBytes"] = entry.logicalBytes;
+    entryJson["fileBytes"] = entry.fileBytes;
+    entryJson["flashBytes"] = entry.flashBytes;
+    entryJson["erasedBlocks"] = entry.erasedBlocks;
+    if (entry.logicalBytes > 0) entryJson["writeAmplification"] = (float)entry.flashBytes / entry.logicalBytes;
+    else entryJson["writeAmplification"] = nullptr;
+
+    if (op < OP_COUNT) {
+      total.operations += entry.operations;
+      total.logicalBytes += entry.logicalBytes;
+      total.fileBytes += entry.fileBytes;
+      total.flashBytes += entry.flashBytes;
+      total.erasedBlocks += entry.erasedBlocks;
+    }
+  }
+  return total;
+}
+
+/**
+ * @brief Returns the time of a benchmark event. Day 0 is 2024/01/01, mktime() takes care of the month and year.
+ * @param day Day number
+ * @param minutes Minutes after midnight
+ */
+struct tm getBenchTime(int day, int minutes) {
+  struct tm timeInfo = {};
+  timeInfo.tm_year = 2024 - 1900;
+  timeInfo.tm_mday = 1 + day;
+  timeInfo.tm_hour = minutes / 60;
+  timeInfo.tm_min = minutes % 60;
+  mktime(&timeInfo);
+  return timeInfo;
+}
+
+/**
+ * @brief Makes the report of the storage benchmark and stops it.
+ * @details The report has the write amplification per operation and the projected flash lifetime.
+ * @param error Why the benchmark failed, or nullptr if it finished
+ */
+void finishStorageBenchmark(const char* error) {
+  benchStep = -1;
+  xSemaphoreTakeRecursive(storageMutex, portMAX_DELAY);
+  LittleFS.remove(benchPath);
+  xSemaphoreGiveRecursive(storageMutex);
+
+  JsonDocument jsonDoc;
+  jsonDoc["historyDays"] = benchHistoryDays;
+  jsonDoc["touchesPerDay"] = benchTouchesPerDay;
+  jsonDoc["durationMs"] = millis() - benchStartMillis;
+  StorageStats total = addStorageStatsToJson(benchStats, jsonDoc["operations"].to<JsonObject>());
+
+  // LittleFS spreads the erases over the whole partition, so each block gets erasedBlocks / partitionBlocks erases a day
+  size_t partitionBlocks = LittleFS.totalBytes() / SPI_FLASH_SEC_SIZE;
+  jsonDoc["partitionBlocks"] = partitionBlocks;
+  jsonDoc["erasedBlocksPerDay"] = total.erasedBlocks;
+  if (error == nullptr && total.erasedBlocks > 0) {
+    jsonDoc["projectedLifetimeYears"] = (float)partitionBlocks * flashEraseCycles / total.erasedBlocks / 365;
+  } else {
+    jsonDoc["projectedLifetimeYears"] = nullptr;
+  }
+  if (error != nullptr) jsonDoc["error"] = error;
+
+  String report;
+  serializeJson(jsonDoc, report);
+  Serial.println("Storage benchmark: " + report);
+
+  xSemaphoreTakeRecursive(storageMutex, portMAX_DELAY);  // /storage-stats reads benchReport from the web server task
+  benchReport = report;
+  xSemaphoreGiveRecursive(storageMutex);
+}
+
+/**
+ * @brief Starts the storage benchmark, which replays a day in the shop on benchPath.
+ * @details The workload is always the same, so runs can be compared:
+ *          - The file is first filled with benchHistoryDays of old rows (not counted), so rewrites cost what they do after a while in use
+ *          - 5 test touches at opening, removed again with "Clear List for Today"
+ *          - benchTouchesPerDay touches spread over 09:00-18:00
+ *          - A "-" after every 50th touch for a double count and 2 "+" for missed customers
+ *          The real data is not touched and the operations are counted in benchStats, not the live counters.
+ *          The replay itself runs one operation per loop() with runStorageBenchmarkStep(), so touches are still counted.
+ */
+void startStorageBenchmark() {
+  Serial.println("Running storage benchmark...");
+  benchStartMillis = millis();
+  for (StorageStats &stats : benchStats) stats = {stats.name};
+  benchDate = getDate(getBenchTime(benchHistoryDays, 0));
+
+  // Fill the file with history. The lock keeps these flash writes out of the counters of other operations.
+  xSemaphoreTakeRecursive(storageMutex, portMAX_DELAY);
+  File file = LittleFS.open(benchPath, FILE_WRITE);
+  bool isWritten = (bool)file;
+  if (file) {
+    isWritten = file.println("customer,date,time") > 0;
+    for (int day = 0; day < benchHistoryDays && isWritten; day++) {
+      for (int i = 0; i < benchTouchesPerDay && isWritten; i++) {
+        struct tm timeInfo = getBenchTime(day, 9 * 60 + i * 9 * 60 / benchTouchesPerDay);
+        isWritten = file.println("1," + getDate(timeInfo) + "," + getTime(timeInfo)) > 0;
+      }
+    }
+    file.close();
+  }
+  xSemaphoreGiveRecursive(storageMutex);
+
+  if (!isWritten) {
+    finishStorageBenchmark("Could not write the benchmark file.");
+    return;
+  }
+  benchStep = 0;
+}
+
+/**
+ * @brief Runs the next operation of the storage benchmark. Called from loop() while benchStep >= 0.
+ * @details Step 0-4 are the test touches and step 5 clears them. After that every touch has 3 steps:
+ *          the touch, maybe a "-" and maybe a "+". The benchmark fails if an operation fails,
+ *          since the rest would then be measured on a different file.
+ */
+void runStorageBenchmarkStep() {
+  int stepCount = 6 + 3 * benchTouchesPerDay;
+  if (benchStep >= stepCount) {
+    finishStorageBenchmark(nullptr);
+    return;
+  }
+
+  bool isSuccess = true;
+  if (benchStep < 5) {
+    isSuccess = appendToCSV(benchPath, benchDate, "08:55");
+  } else if (benchStep == 5) {
+    isSuccess = removeLinesWithDate(benchPath, benchDate);
+  } else {
+    int touch = (benchStep - 6) / 3 + 1;
+    String time = getTime(getBenchTime(benchHistoryDays, 9 * 60 + touch * 9 * 60 / benchTouchesPerDay));
+    switch ((benchStep - 6) % 3) {
+      case 0:  // The touch
+        isSuccess = appendToCSV(benchPath, benchDate, time);
+        break;
+      case 1:  // "-" for a double count
+        if (touch % 50 == 0) isSuccess = removeLatestEntryOnDate(benchPath, benchDate);
+        break;
+      case 2:  // "+" for a missed customer
+        if (touch % max(benchTouchesPerDay / 2, 1) == 0) isSuccess = appendToCSV(benchPath, benchDate, time);
+        break;
+    }
+  }
+
+  if (!isSuccess) {
+    finishStorageBenchmark("An operation failed, the rest would be measured on a different file.");
+    return;
+  }
+  benchStep++;
+}
+
 /**
  * @brief Handles touch event and appends the current date and time to the CSV file.
  */
@@ -518,6 +1302,7 @@ void setup() {
 
   // Initialize the LittleFS filesystem
   initLittleFS();
+  csvGeneration = esp_random();
 
   // Load SSID and password from saved configuration files
   ssid = readConfigFiles(LittleFS, ssidPath);
@@ -558,7 +1343,7 @@ void setup() {
      * @details This serves the index.html file from LittleFS when accessed via HTTP GET request.
      */
     server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
-      request->send(LittleFS, "/index.html", String(), false);
+      sendPage(request, "/index.html");
     });
 
     /** 
@@ -566,22 +1351,39 @@ void setup() {
      * @details This serves the services.html file from LittleFS when accessed via HTTP GET request.
      */
     server.on("/services.html", HTTP_GET, [](AsyncWebServerRequest *request){
-      request->send(LittleFS, "/services.html", String(), false);
+      sendPage(request, "/services.html");
     });
     
     /** 
-     * @brief Route to load the style.css file
-     * @details This serves the style.css file from LittleFS with the appropriate MIME type for CSS when accessed via HTTP GET request.
+     * @brief Route for the fingerprinted assets (style.css, favicon.png)
+     * @details Serves the gzipped files from /assets/ with an immutable Cache-Control header.
      */
-    server.on("/style.css", HTTP_GET, [](AsyncWebServerRequest *request){
-      request->send(LittleFS, "/style.css", "text/css");
-    });
+    server.serveStatic(assetsPath, LittleFS, assetsPath).setCacheControl(assetCacheControl);
 
     /** 
      * @brief Handles a GET request to fetch data in JSON format
      * @details This reads the CSV file, processes the dates, and returns the date counts as a JSON response.
+     *          With format=bin it returns the counts per day in the binary format from writeDayCounts() instead.
+     *          The file is then read line by line instead of all at once.
      */
     server.on("/get-data", HTTP_GET, [](AsyncWebServerRequest *request) {
+      if (request->hasParam("format") && request->getParam("format")->value() == "bin") {
+        File file = LittleFS.open(csvPath, FILE_READ);
+        if (!file) {
+          request->send(500, "text/plain", "Could not open the CSV file.");
+          return;
+        }
+        std::vector<uint32_t> counts;
+        long startDay;
+        countDays(file, counts, startDay);
+        file.close();
+
+        AsyncResponseStream *response = request->beginResponseStream("application/octet-stream");
+        writeDayCounts(*response, counts, startDay);
+        request->send(response);
+        return;
+      }
+
       const char* csvData = readCsvFile(LittleFS, csvPath);
       Serial.println(csvData);
       String jsonResponse = countDates(csvData);
@@ -664,6 +1466,129 @@ void setup() {
       request->send(200, "text/plain", isSuccess);
     });
 
+    /** 
+     * @brief Compares the size and encode time of the JSON and binary /get-data formats.
+     * @details Makes test data with the days and perDay parameters (default 365 days with 8 rows each)
+     *          and encodes it with countDates() (ArduinoJson) and with countDays() + writeDayCounts().
+     */
+    server.on("/get-data-bench", HTTP_GET, [](AsyncWebServerRequest *request){
+      int days = request->hasParam("days") ? request->getParam("days")->value().toInt() : 365;
+      int perDay = request->hasParam("perDay") ? request->getParam("perDay")->value().toInt() : 8;
+      // Bound each value before multiplying, so the check can't overflow
+      if (days <= 0 || perDay <= 0 || days > dataBenchMaxRows || perDay > dataBenchMaxRows / days) {
+        request->send(400, "text/plain", "days * perDay must be between 1 and " + String(dataBenchMaxRows) + ".");
+        return;
+      }
+      size_t rows = (size_t)days * perDay;
+
+      // Make the test data, day 0 is 2024/01/01
+      String csv = "customer,date,time\r\n";
+      if (!csv.reserve(rows * 20 + 20)) {
+        request->send(503, "text/plain", "Not enough memory for the test data.");
+        return;
+      }
+      for (int day = 0; day < days; day++) {
+        struct tm timeInfo = {};
+        timeInfo.tm_year = 2024 - 1900;
+        timeInfo.tm_mday = 1 + day;
+        timeInfo.tm_hour = 12;
+        mktime(&timeInfo);
+        String line = "1," + getDate(timeInfo) + "," + getTime(timeInfo) + "\r\n";
+        for (int i = 0; i < perDay; i++) csv += line;
+      }
+
+      unsigned long startMicros = micros();
+      String jsonOutput = countDates(csv.c_str());
+      unsigned long jsonMicros = micros() - startMicros;
+
+      startMicros = micros();
+      CharStream csvStream(csv.c_str(), csv.length());  // Reads the same data as countDates(), without a copy
+      std::vector<uint32_t> counts;
+      long startDay;
+      countDays(csvStream, counts, startDay);
+      StreamString binOutput;
+      size_t binBytes = writeDayCounts(binOutput, counts, startDay);
+      unsigned long binMicros = micros() - startMicros;
+
+      JsonDocument jsonDoc;
+      jsonDoc["rows"] = rows;
+      jsonDoc["days"] = days;
+      jsonDoc["json"]["bytes"] = jsonOutput.length();
+      jsonDoc["json"]["encodeMicros"] = jsonMicros;
+      jsonDoc["bin"]["bytes"] = binBytes;
+      jsonDoc["bin"]["encodeMicros"] = binMicros;
+
+      String jsonResponse;
+      serializeJson(jsonDoc, jsonResponse);
+      Serial.println("Get data benchmark: " + jsonResponse);
+      request->send(200, "application/json", jsonResponse);
+    });
+
+    /** 
+     * @brief Returns the flash write counters.
+     * @details "live" has the counters since boot per kind of operation, "benchmark" the report from the last storage benchmark.
+     *          The benchmark is not included in "live".
+     */
+    server.on("/storage-stats", HTTP_GET, [](AsyncWebServerRequest *request){
+      JsonDocument jsonDoc;
+      xSemaphoreTakeRecursive(storageMutex, portMAX_DELAY);
+      addStorageStatsToJson(storageStats, jsonDoc["live"].to<JsonObject>());
+      jsonDoc["flashBytes"] = flashBytesWritten;
+      jsonDoc["erasedBlocks"] = flashBlocksErased;
+      jsonDoc["benchmarkRunning"] = benchStep >= 0 || isBenchmarkRequested;
+      if (benchReport.length() > 0) jsonDoc["benchmark"] = serialized(benchReport);
+      else jsonDoc["benchmark"] = nullptr;
+      xSemaphoreGiveRecursive(storageMutex);
+
+      AsyncResponseStream *response = request->beginResponseStream("application/json");
+      serializeJson(jsonDoc, *response);
+      request->send(response);
+    });
+
+    /** 
+     * @brief Starts the storage benchmark.
+     * @details Optional parameters: history (days of old rows, default 5) and touches (per day, default 300).
+     *          (history + 1) * touches must stay below benchMaxRows, so the file fits in RAM when it is rewritten.
+     *          The benchmark runs from loop(), one operation per loop, so touches are still counted while it runs.
+     *          It has its own counters, so it does not mix with the live ones. The report shows up on /storage-stats.
+     */
+    server.on("/storage-bench", HTTP_POST, [](AsyncWebServerRequest *request){
+      if (benchStep >= 0 || isBenchmarkRequested) {
+        request->send(409, "text/plain", "A benchmark is already running.");
+        return;
+      }
+      int historyDays = request->hasParam("history") ? request->getParam("history")->value().toInt() : 5;
+      int touchesPerDay = request->hasParam("touches") ? request->getParam("touches")->value().toInt() : 300;
+      // Bound each value before multiplying, so the check can't overflow
+      if (historyDays < 0 || touchesPerDay < 1 || historyDays > benchMaxRows || touchesPerDay > benchMaxRows
+          || historyDays + 1 > (benchMaxRows - 10) / touchesPerDay) {
+        request->send(400, "text/plain", "(history + 1) * touches must be below " + String(benchMaxRows) + ".");
+        return;
+      }
+      benchHistoryDays = historyDays;
+      benchTouchesPerDay = touchesPerDay;
+      isBenchmarkRequested = true;
+      request->send(202, "text/plain", "Benchmark started. The report will be on /storage-stats.");
+    });
+
+    /** 
+     * @brief Returns the state of the WiFi connection.
+     * @details Includes how many times superviseWiFi() has reconnected and how long the last reconnect took.
+     */
+    server.on("/wifi-status", HTTP_GET, [](AsyncWebServerRequest *request){
+      JsonDocument jsonDoc;
+      jsonDoc["connected"] = WiFi.status() == WL_CONNECTED;
+      jsonDoc["rssi"] = WiFi.RSSI();
+      jsonDoc["channel"] = WiFi.channel();
+      jsonDoc["bssid"] = WiFi.BSSIDstr();
+      jsonDoc["reconnects"] = reconnectCount;
+      jsonDoc["lastReconnectMs"] = lastReconnectDuration;
+
+      String jsonResponse;
+      serializeJson(jsonDoc, jsonResponse);
+      request->send(200, "application/json", jsonResponse);
+    });
+
     /** 
      * @brief Clears all WiFi configurations (SSID, password, IP, and gateway).
      * @details This handles a DELETE request to clear WiFi configurations from the LittleFS storage.
@@ -672,8 +1597,9 @@ void setup() {
     server.on("/clear-wifi", HTTP_DELETE, [](AsyncWebServerRequest *request){
       bool ssidCleared = clearFile(ssidPath);
       bool passCleared = clearFile(passPath);
+      bool cacheCleared = clearWiFiCache();
 
-      String isSuccess = ssidCleared && passCleared ? "Task Completed Successfully" : "Task ended up in failure.";
+      String isSuccess = ssidCleared && passCleared && cacheCleared ? "Task Completed Successfully" : "Task ended up in failure.";
 
       request->send(200, "text/plain", isSuccess);
       Serial.println("WiFi Configs have been cleared. Will restart in 3 seconds!");
@@ -684,10 +1610,146 @@ void setup() {
     /** 
      * @brief Route to download the CSV file.
      * @details This handles a GET request to allow the user to download the current CSV file from LittleFS storage.
+     *          The optional from and to parameters (yyyy/mm/dd) only send the rows in that date range. The start and
+     *          end are found with seekToDate(), so the file is not filtered line by line.
+     *          HTTP Range and If-Range are supported, so an interrupted download can be resumed and a sync can fetch
+     *          only the bytes added since last time. The body is read from the file while it is sent.
      */
     server.on("/download-csv", HTTP_GET, [](AsyncWebServerRequest *request){
       Serial.println("Download CSV Request received!");
-      request->send(LittleFS, csvPath, String(), true);
+
+      File file = LittleFS.open(csvPath, FILE_READ);
+      if (!file) {
+        request->send(500, "text/plain", "Could not open the CSV file.");
+        return;
+      }
+      String etag = "\"" + String(file.size(), HEX) + "-" + String((unsigned long)file.getLastWrite(), HEX) + "\"";
+
+      // Find the part of the file to send
+      size_t fileStart = 0;
+      size_t fileEnd = file.size();
+      String prefix;  // Header line, sent first when the rows start later in the file
+      if (request->hasParam("from")) {
+        fileStart = seekToDate(file, request->getParam("from")->value());
+        file.seek(0);
+        String header = file.readStringUntil('\n');
+        if (fileStart > 0 && header.startsWith("customer")) prefix = header + "\n";
+      }
+      if (request->hasParam("to")) {
+        // '~' sorts after every digit, so this finds the first line after the to date
+        fileEnd = max(seekToDate(file, request->getParam("to")->value() + "~"), fileStart);
+      }
+      size_t length = prefix.length() + fileEnd - fileStart;
+
+      // Only use the Range if the file has not changed since the client got its If-Range ETag
+      size_t rangeStart = 0;
+      size_t rangeEnd = length;
+      bool isRange = request->hasHeader("Range")
+                     && (!request->hasHeader("If-Range") || request->getHeader("If-Range")->value() == etag);
+      if (isRange && !parseRange(request->getHeader("Range")->value(), length, rangeStart, rangeEnd)) {
+        AsyncWebServerResponse *response = request->beginResponse(416, "text/plain", "Range Not Satisfiable");
+        response->addHeader("Content-Range", "bytes */" + String(length));
+        request->send(response);
+        return;
+      }
+
+      AsyncWebServerResponse *response = request->beginResponse("text/csv", rangeEnd - rangeStart,
+        [file, prefix, fileStart, rangeStart, rangeEnd](uint8_t *buffer, size_t maxLen, size_t index) mutable -> size_t {
+          size_t pos = rangeStart + index;  // Position in the body
+          if (pos >= rangeEnd) return 0;
+          maxLen = min(maxLen, rangeEnd - pos);
+
+          size_t written = 0;
+          if (pos < prefix.length()) {
+            written = min(maxLen, prefix.length() - pos);
+            memcpy(buffer, prefix.c_str() + pos, written);
+            pos += written;
+          }
+          if (written < maxLen) {
+            file.seek(fileStart + pos - prefix.length());
+            written += file.read(buffer + written, maxLen - written);
+          }
+          return written;
+        });
+
+      if (isRange && (rangeStart > 0 || rangeEnd < length)) {
+        response->setCode(206);
+        response->addHeader("Content-Range", "bytes " + String(rangeStart) + "-" + String(rangeEnd - 1) + "/" + String(length));
+      }
+      response->addHeader("Accept-Ranges", "bytes");
+      response->addHeader("ETag", etag);
+      response->addHeader("Content-Disposition", "attachment; filename=\"customer-list.csv\"");
+      request->send(response);
+    });
+
+    /** 
+     * @brief Returns the raw events one page at a time.
+     * @details Query parameters: cursor, limit, from and to (dates in yyyy/mm/dd format).
+     *          The response is {"events": [{"date", "time"}], "next": cursor or null}.
+     *          The cursor is opaque to the client, but it is "<csvGeneration>-<byte offset of the next line>",
+     *          so the next page is a seek and not a rescan. Without a cursor the start is found with seekToDate().
+     *          If the file has been rewritten since the cursor was made (a "-" or a clear), the offsets have moved,
+     *          so the request gets 410 and the client must start paging again without a cursor.
+     */
+    server.on("/events", HTTP_GET, [](AsyncWebServerRequest *request){
+      String fromDate = request->hasParam("from") ? request->getParam("from")->value() : String();
+      String toDate = request->hasParam("to") ? request->getParam("to")->value() : String();
+      String cursor = request->hasParam("cursor") ? request->getParam("cursor")->value() : String();
+
+      int limit = request->hasParam("limit") ? request->getParam("limit")->value().toInt() : eventsDefaultLimit;
+      if (limit <= 0) limit = eventsDefaultLimit;
+      if (limit > eventsMaxLimit) limit = eventsMaxLimit;
+
+      // Parse the cursor before opening the file
+      uint32_t generation = 0;
+      size_t offset = 0;
+      if (cursor.length() > 0) {
+        char* end;
+        generation = strtoul(cursor.c_str(), &end, 16);
+        bool isValid = *end == '-';
+        if (isValid) {
+          const char* offsetStart = end + 1;
+          offset = strtoul(offsetStart, &end, 16);
+          isValid = *offsetStart != '\0' && *end == '\0';
+        }
+        if (!isValid) {
+          request->send(400, "text/plain", "Invalid cursor.");
+          return;
+        }
+      }
+
+      // Hold the storage lock so the file can't be rewritten while the page is read
+      xSemaphoreTakeRecursive(storageMutex, portMAX_DELAY);
+      File file = LittleFS.open(csvPath, FILE_READ);
+      if (!file) {
+        xSemaphoreGiveRecursive(storageMutex);
+        request->send(500, "text/plain", "Could not open the CSV file.");
+        return;
+      }
+
+      if (cursor.length() > 0) {
+        if (generation != csvGeneration || offset > file.size()) {
+          file.close();
+          xSemaphoreGiveRecursive(storageMutex);
+          request->send(410, "text/plain", "The CSV file has changed since this cursor was made. Start again without a cursor.");
+          return;
+        }
+        file.seek(offset);
+      }
+      else if (fromDate.length() > 0) {
+        seekToDate(file, fromDate);
+      }
+
+      JsonDocument jsonDoc;
+      size_t next = readEvents(file, jsonDoc["events"].to<JsonArray>(), limit, fromDate, toDate);
+      if (next > 0) jsonDoc["next"] = String(csvGeneration, HEX) + "-" + String(next, HEX);
+      else jsonDoc["next"] = nullptr;
+      file.close();
+      xSemaphoreGiveRecursive(storageMutex);
+
+      AsyncResponseStream *response = request->beginResponseStream("application/json");
+      serializeJson(jsonDoc, *response);
+      request->send(response);
     });
 
     // Start the web server
@@ -698,10 +1760,17 @@ void setup() {
    * 
    * @details This function sets up a WiFi access point, allowing the user to connect to it and access the WiFi Manager page. 
    * The page uses `wifimanager.html` to collect the user's input, which is then saved to text files for WiFi credentials (SSID and password).
+   * If a WiFi is already saved, loop() keeps trying it in the background while no one is connected to the AP,
+   * and restarts the ESP once it connects.
    */
   else {
     // Connect to Wi-Fi network with SSID and password
     Serial.println("Setting AP (Access Point)");
+    // If there is a saved WiFi, keep the station on so loop() can keep trying it (e.g. the router is still booting after a power cut)
+    if (ssid != "") {
+      WiFi.mode(WIFI_AP_STA);
+      isRetryingWiFi = true;
+    }
     // NULL sets an open Access Point
     WiFi.softAP("RasmusW-Wifi-Manager", NULL);
 
@@ -711,9 +1780,10 @@ void setup() {
 
     /** Web Server Root URL*/
     server.on("/", HTTP_GET, [](AsyncWebServerRequest *request){
-      request->send(LittleFS, "/wifimanager.html", "text/html");
+      sendPage(request, "/wifimanager.html");
     });
     
+    server.serveStatic(assetsPath, LittleFS, assetsPath).setCacheControl(assetCacheControl);
     server.serveStatic("/", LittleFS, "/");
     
     /**
@@ -737,6 +1807,7 @@ void setup() {
             Serial.print("SSID set to: ");
             Serial.println(ssid);
             writeToConfigFiles(LittleFS, ssidPath, ssid.c_str());  // Save SSID to file
+            clearWiFiCache();  // The cache belongs to the old WiFi
           }
           // Process password parameter
           if (p->name() == PARAM_INPUT_2) {
@@ -758,15 +1829,38 @@ void setup() {
 /**
  * @brief Main loop of the program. Runs continuously to check the WiFi connection and handle touch input.
  * 
- * This function first checks if the device is connected to WiFi. If not, it exits early.
- * If connected, it reads the touch sensor value and checks if it is below the threshold.
+ * This function first checks if the device is connected to WiFi. If not, it keeps trying the saved WiFi 
+ * with superviseWiFi() (if there is one and nobody is connected to the AP) and restarts the ESP when it connects, then it exits early.
+ * If connected, it lets superviseWiFi() keep the connection alive and then reads the touch sensor value and checks if it is below the threshold.
  * If the threshold is met, it calls the onTouch() function and sets the isTouched flag to true.
  * If the touch value is above the threshold, it resets the isTouched flag.
  */
 void loop() {
-  if (!isConnectedWiFi) return;
+  if (!isConnectedWiFi) {
+    // Pause while someone is on the WiFi Manager, since the scans and channel changes would disturb them
+    // (the saved password might be the reason we are in AP mode)
+    if (isRetryingWiFi && WiFi.softAPgetStationNum() == 0) {
+      superviseWiFi();
+      if (WiFi.status() == WL_CONNECTED) {  // Restart so setup() starts the counter and its web server
+        Serial.println("Connected to the saved WiFi. Will restart in 3 seconds!");
+        delay(3000);
+        ESP.restart();
+      }
+    }
+    return;
+  }
   else
   {
+    superviseWiFi();
+
+    if (isBenchmarkRequested) {
+      isBenchmarkRequested = false;
+      startStorageBenchmark();
+    }
+    else if (benchStep >= 0) {
+      runStorageBenchmarkStep();
+    }
+
       // read the state of the pushbutton value:
     int touchValue = touchRead(touchPin);
     // check if the touchValue is below the threshold